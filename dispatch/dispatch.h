@@ -0,0 +1,388 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#define DISPATCH_X86
+#include <cpuid.h>
+#endif
+#include "../common/bits.h"
+#include "../unsigned/runtime/unsigned_division.h"
+#include "../signed/runtime/signed_division.h"
+
+// CPU features that are relevant for choosing a division implementation
+#define FEATURE_BMI2   1
+#define FEATURE_AVX2   2
+#define FEATURE_AVX512 4
+
+typedef void (*unsigned_batch_fn)(const uint *n, uint *q, size_t count, uint d, udivdata_t dd);
+typedef void (*signed_batch_fn)(const sint *n, sint *q, size_t count, sint d, sdivdata_t dd);
+
+typedef struct {
+	const char *name;
+	unsigned required_features;
+	unsigned_batch_fn divide;
+	bool supported;
+	double ns_per_division;
+} unsigned_candidate_t;
+
+typedef struct {
+	const char *name;
+	unsigned required_features;
+	signed_batch_fn divide;
+	bool supported;
+	double ns_per_division;
+} signed_candidate_t;
+
+typedef struct {
+	unsigned_batch_fn unsigned_divide;
+	signed_batch_fn signed_divide;
+	const unsigned_candidate_t *unsigned_choice;
+	const signed_candidate_t *signed_choice;
+	unsigned features;
+} dispatch_table_t;
+
+unsigned detect_cpu_features();
+void init_dispatch();
+void dispatch_unsigned_divide(const uint *n, uint *q, size_t count, uint d, udivdata_t dd);
+void dispatch_signed_divide(const sint *n, sint *q, size_t count, sint d, sdivdata_t dd);
+const dispatch_table_t *dispatch_report();
+void print_dispatch_report(FILE *f);
+
+
+// Candidate implementations
+
+void hardware_unsigned_batch(const uint *n, uint *q, size_t count, uint d, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = n[i] / d;
+}
+
+void hardware_signed_batch(const sint *n, sint *q, size_t count, sint d, sdivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = n[i] / d;
+}
+
+// The multiply-shift division one element at a time. Vectorization is turned
+// off explicitly, so that these can be compared to the vectorized loops below.
+__attribute__((optimize("no-tree-vectorize")))
+void fast_unsigned_batch(const uint *__restrict__ n, uint *__restrict__ q, size_t count, uint d, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_unsigned_divide(n[i], dd);
+}
+
+__attribute__((optimize("no-tree-vectorize")))
+void fast_signed_batch(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sint d, sdivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_signed_divide(n[i], dd);
+}
+
+// The batch forms from the headers, which are vectorized for the baseline
+// target (SSE2 on x86-64).
+void fast_unsigned_batch_vector(const uint *__restrict__ n, uint *__restrict__ q, size_t count, uint d, udivdata_t dd) {
+	fast_unsigned_divide_batch(n, q, count, dd);
+}
+
+void fast_signed_batch_vector(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sint d, sdivdata_t dd) {
+	fast_signed_divide_batch(n, q, count, dd);
+}
+
+// The same loops, compiled for instruction set extensions that are not part of
+// the baseline target. These must only be called if the CPU supports them.
+#ifdef DISPATCH_X86
+__attribute__((target("bmi2"), optimize("no-tree-vectorize")))
+void fast_unsigned_batch_bmi2(const uint *__restrict__ n, uint *__restrict__ q, size_t count, uint d, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_unsigned_divide(n[i], dd);
+}
+
+__attribute__((target("bmi2"), optimize("no-tree-vectorize")))
+void fast_signed_batch_bmi2(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sint d, sdivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_signed_divide(n[i], dd);
+}
+
+__attribute__((target("avx2,bmi2"), optimize("tree-vectorize")))
+void fast_unsigned_batch_avx2(const uint *__restrict__ n, uint *__restrict__ q, size_t count, uint d, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_unsigned_divide(n[i], dd);
+}
+
+__attribute__((target("avx2,bmi2"), optimize("tree-vectorize")))
+void fast_signed_batch_avx2(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sint d, sdivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_signed_divide(n[i], dd);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi2"), optimize("tree-vectorize")))
+void fast_unsigned_batch_avx512(const uint *__restrict__ n, uint *__restrict__ q, size_t count, uint d, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_unsigned_divide(n[i], dd);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi2"), optimize("tree-vectorize")))
+void fast_signed_batch_avx512(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sint d, sdivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_signed_divide(n[i], dd);
+}
+#endif
+
+unsigned_candidate_t unsigned_candidates[] = {
+	{ "hardware", 0, hardware_unsigned_batch },
+	{ "fast", 0, fast_unsigned_batch },
+#ifdef DISPATCH_X86
+	{ "fast-bmi2", FEATURE_BMI2, fast_unsigned_batch_bmi2 },
+#endif
+	{ "fast-vector", 0, fast_unsigned_batch_vector },
+#ifdef DISPATCH_X86
+	{ "fast-avx2", FEATURE_AVX2 | FEATURE_BMI2, fast_unsigned_batch_avx2 },
+	{ "fast-avx512", FEATURE_AVX512 | FEATURE_AVX2 | FEATURE_BMI2, fast_unsigned_batch_avx512 },
+#endif
+};
+
+signed_candidate_t signed_candidates[] = {
+	{ "hardware", 0, hardware_signed_batch },
+	{ "fast", 0, fast_signed_batch },
+#ifdef DISPATCH_X86
+	{ "fast-bmi2", FEATURE_BMI2, fast_signed_batch_bmi2 },
+#endif
+	{ "fast-vector", 0, fast_signed_batch_vector },
+#ifdef DISPATCH_X86
+	{ "fast-avx2", FEATURE_AVX2 | FEATURE_BMI2, fast_signed_batch_avx2 },
+	{ "fast-avx512", FEATURE_AVX512 | FEATURE_AVX2 | FEATURE_BMI2, fast_signed_batch_avx512 },
+#endif
+};
+
+#define UNSIGNED_CANDIDATES (sizeof(unsigned_candidates) / sizeof(unsigned_candidates[0]))
+#define SIGNED_CANDIDATES (sizeof(signed_candidates) / sizeof(signed_candidates[0]))
+
+// Until init_dispatch has run, use the implementations that work everywhere.
+dispatch_table_t dispatch_table = {
+	hardware_unsigned_batch, hardware_signed_batch,
+	&unsigned_candidates[0], &signed_candidates[0], 0
+};
+
+
+// Implementations
+
+// Use cpuid (and xgetbv, to check that the OS saves the vector registers)
+// to determine which of the FEATURE_* flags are supported.
+unsigned detect_cpu_features() {
+	unsigned features = 0;
+#ifdef DISPATCH_X86
+	unsigned eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+	bool osxsave = ecx & (1 << 27);
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+	if (ebx & (1 << 8)) features |= FEATURE_BMI2;
+
+	if (osxsave) {
+		unsigned xcr0_lo, xcr0_hi;
+		__asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+
+		// XMM and YMM state
+		bool ymm_enabled = (xcr0_lo & 0x06) == 0x06;
+		// opmask, ZMM0-15 and ZMM16-31 state
+		bool zmm_enabled = (xcr0_lo & 0xe0) == 0xe0;
+
+		if (ymm_enabled && (ebx & (1 << 5))) features |= FEATURE_AVX2;
+
+		// avx512f, avx512bw, avx512vl
+		unsigned avx512_bits = (1 << 16) | (1 << 30) | (1u << 31);
+		if (ymm_enabled && zmm_enabled && (ebx & avx512_bits) == avx512_bits)
+			features |= FEATURE_AVX512;
+	}
+#endif
+	return features;
+}
+
+uint64_t dispatch_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#define DISPATCH_BENCHMARK_SIZE 4096
+#define DISPATCH_BENCHMARK_ROUNDS 15
+// Candidates whose median time is within this fraction of the fastest one are
+// considered equally fast, since the differences are within the noise.
+#define DISPATCH_TOLERANCE 0.05
+
+// Sort the samples and return the middle one.
+double dispatch_median(double *samples, int count) {
+	for (int i = 1; i < count; i++)
+		for (int j = i; j > 0 && samples[j - 1] > samples[j]; j--) {
+			double t = samples[j - 1];
+			samples[j - 1] = samples[j];
+			samples[j] = t;
+		}
+	return samples[count / 2];
+}
+
+// Time every supported candidate on a buffer of pseudo-random dividends for a
+// few representative divisors, and store the median time per division in
+// nanoseconds. The rounds of the candidates are interleaved, so that changes
+// in clock frequency or load affect all of them alike.
+void benchmark_unsigned_candidates() {
+	static uint n[DISPATCH_BENCHMARK_SIZE], q[DISPATCH_BENCHMARK_SIZE];
+	static double samples[UNSIGNED_CANDIDATES][DISPATCH_BENCHMARK_ROUNDS];
+	const uint divisors[] = { 7, 10, (uint)(UINT_MAX / 3) };
+
+	uint32_t state = 12345;
+	for (size_t i = 0; i < DISPATCH_BENCHMARK_SIZE; i++) {
+		state = state * 1664525 + 1013904223;
+		n[i] = state >> (32 - N);
+	}
+
+	for (int round = 0; round < DISPATCH_BENCHMARK_ROUNDS; round++) {
+		for (size_t i = 0; i < UNSIGNED_CANDIDATES; i++) {
+			if (!unsigned_candidates[i].supported) continue;
+
+			uint64_t start = dispatch_nanoseconds();
+			for (uint d : divisors)
+				unsigned_candidates[i].divide(n, q, DISPATCH_BENCHMARK_SIZE, d, precompute_unsigned(d));
+			uint64_t end = dispatch_nanoseconds();
+			samples[i][round] = 1.0 * (end - start) / (DISPATCH_BENCHMARK_SIZE * 3);
+		}
+	}
+
+	for (size_t i = 0; i < UNSIGNED_CANDIDATES; i++)
+		if (unsigned_candidates[i].supported)
+			unsigned_candidates[i].ns_per_division = dispatch_median(samples[i], DISPATCH_BENCHMARK_ROUNDS);
+}
+
+void benchmark_signed_candidates() {
+	static sint n[DISPATCH_BENCHMARK_SIZE], q[DISPATCH_BENCHMARK_SIZE];
+	static double samples[SIGNED_CANDIDATES][DISPATCH_BENCHMARK_ROUNDS];
+	const sint divisors[] = { 7, -10, (sint)(UINT_MAX / 6) };
+
+	uint32_t state = 12345;
+	for (size_t i = 0; i < DISPATCH_BENCHMARK_SIZE; i++) {
+		state = state * 1664525 + 1013904223;
+		n[i] = (sint)(state >> (32 - N));
+	}
+
+	for (int round = 0; round < DISPATCH_BENCHMARK_ROUNDS; round++) {
+		for (size_t i = 0; i < SIGNED_CANDIDATES; i++) {
+			if (!signed_candidates[i].supported) continue;
+
+			uint64_t start = dispatch_nanoseconds();
+			for (sint d : divisors)
+				signed_candidates[i].divide(n, q, DISPATCH_BENCHMARK_SIZE, d, precompute_signed(d));
+			uint64_t end = dispatch_nanoseconds();
+			samples[i][round] = 1.0 * (end - start) / (DISPATCH_BENCHMARK_SIZE * 3);
+		}
+	}
+
+	for (size_t i = 0; i < SIGNED_CANDIDATES; i++)
+		if (signed_candidates[i].supported)
+			signed_candidates[i].ns_per_division = dispatch_median(samples[i], DISPATCH_BENCHMARK_ROUNDS);
+}
+
+// Detect the CPU features, benchmark every candidate that the CPU supports,
+// and bind the chosen ones in the dispatch table. Of the candidates that are
+// within DISPATCH_TOLERANCE of the fastest, the first one in the list (the
+// one with the fewest requirements) is chosen, so that noise does not decide.
+// This runs automatically at program startup, but it can be called again to
+// re-tune.
+__attribute__((constructor))
+void init_dispatch() {
+	unsigned features = detect_cpu_features();
+	dispatch_table.features = features;
+
+	for (size_t i = 0; i < UNSIGNED_CANDIDATES; i++) {
+		unsigned_candidate_t *c = &unsigned_candidates[i];
+		c->supported = (c->required_features & features) == c->required_features;
+	}
+	for (size_t i = 0; i < SIGNED_CANDIDATES; i++) {
+		signed_candidate_t *c = &signed_candidates[i];
+		c->supported = (c->required_features & features) == c->required_features;
+	}
+
+	benchmark_unsigned_candidates();
+	benchmark_signed_candidates();
+
+	double fastest = 1e300;
+	for (size_t i = 0; i < UNSIGNED_CANDIDATES; i++)
+		if (unsigned_candidates[i].supported && unsigned_candidates[i].ns_per_division < fastest)
+			fastest = unsigned_candidates[i].ns_per_division;
+	for (size_t i = 0; i < UNSIGNED_CANDIDATES; i++)
+		if (unsigned_candidates[i].supported && unsigned_candidates[i].ns_per_division <= fastest * (1 + DISPATCH_TOLERANCE)) {
+			dispatch_table.unsigned_choice = &unsigned_candidates[i];
+			break;
+		}
+
+	fastest = 1e300;
+	for (size_t i = 0; i < SIGNED_CANDIDATES; i++)
+		if (signed_candidates[i].supported && signed_candidates[i].ns_per_division < fastest)
+			fastest = signed_candidates[i].ns_per_division;
+	for (size_t i = 0; i < SIGNED_CANDIDATES; i++)
+		if (signed_candidates[i].supported && signed_candidates[i].ns_per_division <= fastest * (1 + DISPATCH_TOLERANCE)) {
+			dispatch_table.signed_choice = &signed_candidates[i];
+			break;
+		}
+
+	dispatch_table.unsigned_divide = dispatch_table.unsigned_choice->divide;
+	dispatch_table.signed_divide = dispatch_table.signed_choice->divide;
+}
+
+// Compute q[i] = n[i] / d for 0 <= i < count with the fastest implementation
+// for this CPU. dd must be precompute_unsigned(d), and n and q must not overlap.
+void dispatch_unsigned_divide(const uint *n, uint *q, size_t count, uint d, udivdata_t dd) {
+	dispatch_table.unsigned_divide(n, q, count, d, dd);
+}
+
+// Compute q[i] = n[i] / d for 0 <= i < count with the fastest implementation
+// for this CPU. dd must be precompute_signed(d), and n and q must not overlap.
+// For d == -1, SINT_MIN / -1 does not fit in sint. Hardware division traps on
+// it, so this case always uses the fast division, which gives SINT_MIN.
+void dispatch_signed_divide(const sint *n, sint *q, size_t count, sint d, sdivdata_t dd) {
+	if (d == -1)
+		fast_signed_batch(n, q, count, d, dd);
+	else
+		dispatch_table.signed_divide(n, q, count, d, dd);
+}
+
+// Returns the bound implementations and the detected CPU features. The
+// measured timings of all candidates are in unsigned_candidates and
+// signed_candidates.
+const dispatch_table_t *dispatch_report() {
+	return &dispatch_table;
+}
+
+// Print the detected CPU features and the timing of each candidate, which
+// explains the choice that was made.
+void print_dispatch_report(FILE *f) {
+	unsigned features = dispatch_table.features;
+	fprintf(f, "CPU features:%s%s%s%s\n",
+		features & FEATURE_BMI2 ? " bmi2" : "",
+		features & FEATURE_AVX2 ? " avx2" : "",
+		features & FEATURE_AVX512 ? " avx512" : "",
+		features ? "" : " none");
+	fprintf(f, "Median of %d rounds; the first candidate within %.0f%% of the fastest is chosen\n",
+		DISPATCH_BENCHMARK_ROUNDS, DISPATCH_TOLERANCE * 100);
+
+	fprintf(f, "Unsigned %u-bit division:\n", N);
+	for (size_t i = 0; i < UNSIGNED_CANDIDATES; i++) {
+		const unsigned_candidate_t *c = &unsigned_candidates[i];
+		if (c->supported)
+			fprintf(f, "  %-12s %8.3f ns per division%s\n", c->name, c->ns_per_division,
+				c == dispatch_table.unsigned_choice ? "  <- chosen" : "");
+		else
+			fprintf(f, "  %-12s not supported by this CPU\n", c->name);
+	}
+
+	fprintf(f, "Signed %u-bit division:\n", N);
+	for (size_t i = 0; i < SIGNED_CANDIDATES; i++) {
+		const signed_candidate_t *c = &signed_candidates[i];
+		if (c->supported)
+			fprintf(f, "  %-12s %8.3f ns per division%s\n", c->name, c->ns_per_division,
+				c == dispatch_table.signed_choice ? "  <- chosen" : "");
+		else
+			fprintf(f, "  %-12s not supported by this CPU\n", c->name);
+	}
+}
+
+#endif
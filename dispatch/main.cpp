@@ -0,0 +1,65 @@
+#include <stdio.h>
+
+#define N 8
+#include "../common/bits.h"
+#include "dispatch.h"
+
+#if N == 8 || N == 16
+void test_candidates();
+#endif
+
+int main() {
+	print_dispatch_report(stdout);
+	printf("Chose '%s' for unsigned and '%s' for signed division.\n",
+		dispatch_report()->unsigned_choice->name, dispatch_report()->signed_choice->name);
+#if N == 8 || N == 16
+	printf("Testing all supported candidates on all %u-bit integers. This might take a while...\n", N);
+	test_candidates();
+	printf("Done!\n");
+#endif
+	return 0;
+}
+
+#if N == 8 || N == 16
+// Test every candidate that this CPU supports, and the dispatched functions,
+// on all dividends n and all divisors d.
+void test_candidates() {
+	static uint un[1 << N], uq[1 << N];
+	static sint sn[1 << N], sq[1 << N];
+	for (size_t i = 0; i < (1 << N); i++) {
+		un[i] = i;
+		sn[i] = SINT_MIN + i;
+	}
+
+	for (uint d = 1; true; d++) {
+		udivdata_t dd = precompute_unsigned(d);
+		for (size_t c = 0; c <= UNSIGNED_CANDIDATES; c++) {
+			if (c < UNSIGNED_CANDIDATES && !unsigned_candidates[c].supported) continue;
+			if (c < UNSIGNED_CANDIDATES) unsigned_candidates[c].divide(un, uq, 1 << N, d, dd);
+			else dispatch_unsigned_divide(un, uq, 1 << N, d, dd);
+			for (size_t i = 0; i < (1 << N); i++)
+				assert(uq[i] == un[i] / d);
+		}
+		if (d == UINT_MAX) break;
+	}
+
+	for (sint d = SINT_MIN; true; d++) {
+		if (d == 0) d++;
+		sdivdata_t dd = precompute_signed(d);
+		// Skip n = SINT_MIN for d = -1, since the quotient does not fit in sint
+		size_t start = d == -1 ? 1 : 0;
+		for (size_t c = 0; c <= SIGNED_CANDIDATES; c++) {
+			if (c < SIGNED_CANDIDATES && !signed_candidates[c].supported) continue;
+			if (c < SIGNED_CANDIDATES) signed_candidates[c].divide(sn + start, sq + start, (1 << N) - start, d, dd);
+			else dispatch_signed_divide(sn + start, sq + start, (1 << N) - start, d, dd);
+			for (size_t i = start; i < (1 << N); i++)
+				assert(sq[i] == sn[i] / d);
+		}
+		if (d == SINT_MAX) break;
+	}
+
+	// The dispatcher does not trap on SINT_MIN / -1, whichever candidate won
+	dispatch_signed_divide(sn, sq, 1, -1, precompute_signed(-1));
+	assert(sq[0] == SINT_MIN);
+}
+#endif
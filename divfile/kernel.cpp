@@ -0,0 +1,55 @@
+// N is passed by the Makefile, which builds one program per integer size
+#ifndef N
+#define N 32
+#endif
+
+#include "kernel.h"
+#include "../common/bits.h"
+#include "../dispatch/dispatch.h"
+
+const size_t element_size = N / 8;
+
+bool divide_signed;
+uint unsigned_divisor;
+udivdata_t unsigned_divdata;
+unsigned_batch_fn unsigned_kernel;
+sint signed_divisor;
+sdivdata_t signed_divdata;
+signed_batch_fn signed_kernel;
+
+// Select the divisor and the kernel. Returns false if the divisor is zero or
+// does not fit in N bits. Unless use_hardware is set, the kernel is the one
+// that the dispatcher found to be the fastest on this CPU.
+bool set_divisor(int64_t divisor, bool is_signed, bool use_hardware) {
+	divide_signed = is_signed;
+	if (divisor == 0) return false;
+
+	if (is_signed) {
+		// Compare in int64_t, since SINT_MIN overflows int for N == 32
+		int64_t limit = (int64_t)1 << (N - 1);
+		if (divisor < -limit || divisor >= limit) return false;
+		signed_divisor = divisor;
+		signed_divdata = precompute_signed(signed_divisor);
+		// Hardware division traps on SINT_MIN / -1, the dispatcher handles it
+		signed_kernel = use_hardware && divisor != -1 ? hardware_signed_batch : dispatch_signed_divide;
+	}
+	else {
+		if (divisor < 0 || divisor > UINT_MAX) return false;
+		unsigned_divisor = divisor;
+		unsigned_divdata = precompute_unsigned(unsigned_divisor);
+		unsigned_kernel = use_hardware ? hardware_unsigned_batch : dispatch_unsigned_divide;
+	}
+	return true;
+}
+
+// Divide count integers from input by the divisor and store them in output.
+void divide_elements(const void *input, void *output, size_t count) {
+	if (divide_signed)
+		signed_kernel((const sint *)input, (sint *)output, count, signed_divisor, signed_divdata);
+	else
+		unsigned_kernel((const uint *)input, (uint *)output, count, unsigned_divisor, unsigned_divdata);
+}
+
+void print_kernel_report(FILE *f) {
+	print_dispatch_report(f);
+}
@@ -0,0 +1,20 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Interface between the command-line program and the division kernels. The
+// kernels are compiled in a separate translation unit for a fixed N, because
+// bits.h defines a type named uint, which conflicts with the one in the
+// system headers that the command-line program needs for mmap and threads.
+
+// The number of bytes of a single integer in the input and output
+extern const size_t element_size;
+
+bool set_divisor(int64_t divisor, bool is_signed, bool use_hardware);
+void divide_elements(const void *input, void *output, size_t count);
+void print_kernel_report(FILE *f);
+
+#endif
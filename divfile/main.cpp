@@ -0,0 +1,294 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "kernel.h"
+
+// The unit of work that a thread takes at a time, small enough to stay in cache
+#define DEFAULT_CHUNK_SIZE (256 * 1024)
+// The size of the buffers when the input or output is streamed
+#define BLOCK_SIZE (64 * 1024 * 1024)
+// Buffers and the sizes of writes with O_DIRECT need to be aligned to this
+#define DIRECT_ALIGNMENT 4096
+
+typedef struct {
+	const char *name;
+	uint64_t nanoseconds;
+} stage_t;
+
+stage_t read_stage = { "read" }, compute_stage = { "compute" }, write_stage = { "write" };
+
+void usage(const char *program) {
+	fprintf(stderr,
+		"Usage: %s [options] [--] divisor [input [output]]\n"
+		"Divide every %zu-bit integer in input by divisor and write the quotients to output.\n"
+		"The input and output default to stdin and stdout, or use '-'. They must not be the same file.\n"
+		"Numbers are decimal, or hexadecimal with a 0x prefix.\n\n"
+		"Options:\n"
+		"  -s        the integers are signed\n"
+		"  -r        use hardware division instead of the fastest kernel for this CPU\n"
+		"  -d        write the output file with O_DIRECT instead of mapping it\n"
+		"  -t count  number of threads (default: number of CPUs)\n"
+		"  -c bytes  size of the chunks that threads divide at a time (default: %d)\n"
+		"  -v        print the CPU features and the timings of the kernels\n"
+		"  -q        do not print the throughput of each stage\n",
+		program, element_size * 8, DEFAULT_CHUNK_SIZE);
+	exit(2);
+}
+
+void fail(const char *what) {
+	perror(what);
+	exit(1);
+}
+
+// Parse a decimal number, or a hexadecimal one with a 0x prefix. Unlike
+// strtoll with base 0, a leading zero does not make the number octal.
+bool parse_integer(const char *text, long long *value) {
+	const char *digits = text + (*text == '-' || *text == '+');
+	int base = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X') ? 16 : 10;
+	char *end;
+	errno = 0;
+	*value = strtoll(text, &end, base);
+	return end != text && !*end && !errno;
+}
+
+// Parse a number in [1, max] for an option, or exit.
+long parse_positive(const char *program, const char *what, const char *text, long max) {
+	long long value;
+	if (!parse_integer(text, &value) || value <= 0 || value > max) {
+		fprintf(stderr, "%s: the %s must be an integer from 1 to %ld, not '%s'\n", program, what, max, text);
+		exit(2);
+	}
+	return value;
+}
+
+uint64_t get_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Read until size bytes are read or the end of the input is reached, and
+// return the number of bytes read.
+size_t read_fully(int fd, char *buffer, size_t size) {
+	size_t done = 0;
+	while (done < size) {
+		ssize_t n = read(fd, buffer + done, size - done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0) fail("read");
+		if (n == 0) break;
+		done += n;
+	}
+	return done;
+}
+
+void write_fully(int fd, const char *buffer, size_t size) {
+	size_t done = 0;
+	while (done < size) {
+		ssize_t n = write(fd, buffer + done, size - done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0) fail("write");
+		done += n;
+	}
+}
+
+char *allocate_buffer(size_t size) {
+	void *buffer;
+	if (posix_memalign(&buffer, DIRECT_ALIGNMENT, size)) fail("posix_memalign");
+	return (char *)buffer;
+}
+
+// Divide the integers in input[0..bytes) into output[0..bytes). The threads
+// take chunks of chunk_size bytes from a shared counter until all are done.
+void divide_parallel(const char *input, char *output, size_t bytes, unsigned threads, size_t chunk_size) {
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		while (true) {
+			size_t offset = next.fetch_add(chunk_size);
+			if (offset >= bytes) break;
+			size_t size = bytes - offset < chunk_size ? bytes - offset : chunk_size;
+			divide_elements(input + offset, output + offset, size / element_size);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads && (t * chunk_size) < bytes; t++)
+		pool.emplace_back(worker);
+	worker();
+	for (std::thread &thread : pool)
+		thread.join();
+}
+
+void print_stage(const stage_t *stage, uint64_t bytes) {
+	double seconds = stage->nanoseconds / 1e9;
+	if (stage->nanoseconds)
+		fprintf(stderr, "%-8s %9.3f s %9.3f GB/s\n", stage->name, seconds, bytes / 1e9 / seconds);
+	else
+		fprintf(stderr, "%-8s %9.3f s %9s GB/s\n", stage->name, seconds, "-");
+}
+
+int main(int argc, char **argv) {
+	bool is_signed = false, use_hardware = false, direct = false, verbose = false, quiet = false;
+	unsigned threads = std::thread::hardware_concurrency();
+	size_t chunk_size = DEFAULT_CHUNK_SIZE;
+
+	int option;
+	while ((option = getopt(argc, argv, "srdt:c:vq")) != -1) {
+		switch (option) {
+		case 's': is_signed = true; break;
+		case 'r': use_hardware = true; break;
+		case 'd': direct = true; break;
+		case 't': threads = parse_positive(argv[0], "thread count", optarg, UINT_MAX); break;
+		case 'c': chunk_size = parse_positive(argv[0], "chunk size", optarg, LONG_MAX); break;
+		case 'v': verbose = true; break;
+		case 'q': quiet = true; break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind >= argc || argc - optind > 3) usage(argv[0]);
+	if (threads == 0) threads = 1;
+	// Keep chunks aligned to whole integers
+	chunk_size -= chunk_size % element_size;
+	if (chunk_size == 0) usage(argv[0]);
+
+	long long divisor;
+	if (!parse_integer(argv[optind], &divisor) || !set_divisor(divisor, is_signed, use_hardware)) {
+		fprintf(stderr, "%s: the divisor must be a nonzero %s %zu-bit integer\n", argv[0], is_signed ? "signed" : "unsigned", element_size * 8);
+		return 2;
+	}
+	if (verbose) print_kernel_report(stderr);
+
+	const char *input_path = optind + 1 < argc ? argv[optind + 1] : "-";
+	const char *output_path = optind + 2 < argc ? argv[optind + 2] : "-";
+
+	int input_fd = strcmp(input_path, "-") ? open(input_path, O_RDONLY) : 0;
+	if (input_fd < 0) fail(input_path);
+	struct stat input_stat;
+	if (fstat(input_fd, &input_stat)) fail(input_path);
+	bool input_mapped = S_ISREG(input_stat.st_mode) && input_stat.st_size > 0;
+	size_t input_size = input_mapped ? input_stat.st_size : 0;
+	if (input_mapped && input_size % element_size) {
+		fprintf(stderr, "%s: the size of %s is not a multiple of %zu bytes\n", argv[0], input_path, element_size);
+		return 1;
+	}
+
+	bool output_to_file = strcmp(output_path, "-");
+	if (direct && !output_to_file) {
+		fprintf(stderr, "%s: -d needs an output file, O_DIRECT does not apply to stdout\n", argv[0]);
+		return 2;
+	}
+	// Opening the output truncates it, so it must not be the input
+	struct stat output_stat;
+	if (output_to_file && stat(output_path, &output_stat) == 0 &&
+			output_stat.st_dev == input_stat.st_dev && output_stat.st_ino == input_stat.st_ino) {
+		fprintf(stderr, "%s: %s is both the input and the output\n", argv[0], output_path);
+		return 2;
+	}
+	int output_fd = output_to_file ? open(output_path, O_RDWR | O_CREAT | O_TRUNC | (direct ? O_DIRECT : 0), 0644) : 1;
+	if (output_fd < 0 && direct && errno == EINVAL) {
+		fprintf(stderr, "%s: O_DIRECT is not supported for %s, using buffered writes\n", argv[0], output_path);
+		direct = false;
+		output_fd = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	}
+	if (output_fd < 0) fail(output_path);
+	// The output can only be mapped if its size is known in advance
+	bool output_mapped = output_to_file && input_mapped && !direct;
+
+	// Map the input, and let the kernel read it in entirely, so that reading
+	// the file and dividing the integers can be timed separately.
+	const char *input_map = NULL;
+	if (input_mapped) {
+		uint64_t start = get_nanoseconds();
+		void *map = mmap(NULL, input_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, input_fd, 0);
+		if (map == MAP_FAILED) fail("mmap");
+		input_map = (const char *)map;
+		read_stage.nanoseconds += get_nanoseconds() - start;
+	}
+
+	char *output_map = NULL;
+	if (output_mapped) {
+		uint64_t start = get_nanoseconds();
+		if (ftruncate(output_fd, input_size)) fail("ftruncate");
+		void *map = mmap(NULL, input_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, output_fd, 0);
+		if (map == MAP_FAILED) fail("mmap");
+		output_map = (char *)map;
+		write_stage.nanoseconds += get_nanoseconds() - start;
+	}
+
+	// Process the data in blocks, which point into the maps if possible and
+	// are read into or written from aligned buffers otherwise.
+	char *input_buffer = input_mapped ? NULL : allocate_buffer(BLOCK_SIZE);
+	char *output_buffer = output_mapped ? NULL : allocate_buffer(BLOCK_SIZE);
+	size_t block_size = input_mapped && output_mapped ? input_size : BLOCK_SIZE;
+	uint64_t total = 0;
+
+	while (true) {
+		uint64_t read_start = get_nanoseconds();
+		const char *input;
+		size_t size;
+		if (input_mapped) {
+			input = input_map + total;
+			size = input_size - total < block_size ? input_size - total : block_size;
+		}
+		else {
+			size = read_fully(input_fd, input_buffer, BLOCK_SIZE);
+			input = input_buffer;
+			if (size % element_size) {
+				fprintf(stderr, "%s: the size of the input is not a multiple of %zu bytes\n", argv[0], element_size);
+				return 1;
+			}
+		}
+		read_stage.nanoseconds += get_nanoseconds() - read_start;
+		if (size == 0) break;
+
+		uint64_t compute_start = get_nanoseconds();
+		char *output = output_mapped ? output_map + total : output_buffer;
+		divide_parallel(input, output, size, threads, chunk_size);
+		compute_stage.nanoseconds += get_nanoseconds() - compute_start;
+
+		if (!output_mapped) {
+			uint64_t write_start = get_nanoseconds();
+			// With O_DIRECT, only the last block can have an unaligned size.
+			// Write it without O_DIRECT.
+			if (direct && size % DIRECT_ALIGNMENT) {
+				int flags = fcntl(output_fd, F_GETFL);
+				if (flags < 0 || fcntl(output_fd, F_SETFL, flags & ~O_DIRECT)) fail("fcntl");
+			}
+			write_fully(output_fd, output, size);
+			write_stage.nanoseconds += get_nanoseconds() - write_start;
+		}
+		total += size;
+	}
+
+	// Make sure the output is written to the file, so that the write stage
+	// includes the I/O and not only the copy into the page cache.
+	uint64_t sync_start = get_nanoseconds();
+	if (output_mapped && msync(output_map, input_size, MS_SYNC)) fail("msync");
+	else if (output_to_file && !output_mapped && fsync(output_fd)) fail("fsync");
+	write_stage.nanoseconds += get_nanoseconds() - sync_start;
+
+	if (input_mapped) munmap((void *)input_map, input_size);
+	if (output_mapped) munmap(output_map, input_size);
+	free(input_buffer);
+	free(output_buffer);
+	if (output_to_file && close(output_fd)) fail(output_path);
+
+	if (!quiet) {
+		fprintf(stderr, "Divided %llu bytes (input %s, output %s, %u threads, %zu byte chunks)\n",
+			(unsigned long long)total, input_mapped ? "mapped" : "streamed",
+			output_mapped ? "mapped" : direct ? "O_DIRECT" : "streamed", threads, chunk_size);
+		print_stage(&read_stage, total);
+		print_stage(&compute_stage, total);
+		print_stage(&write_stage, total);
+	}
+	return 0;
+}
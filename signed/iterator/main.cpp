@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <time.h>
+
+#define N 8
+#include "../../common/bits.h"
+#include "signed_iterator.h"
+
+void test_strides();
+void test_seek();
+void benchmark();
+
+int main() {
+	printf("Testing iterators for %s %u-bit signed divisors. This might take a while...\n", N == 32 ? "a sample of the" : "all", N);
+	test_strides();
+	test_seek();
+	printf("Done!\n");
+	benchmark();
+	return 0;
+}
+
+uint64_t get_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Returns the divisor after d that is tested, or 0 if d is the last one.
+// For N == 32, not all divisors are tested, but divisors close to zero are
+// tested exhaustively and the others are sampled over the whole range.
+sint next_divisor(sint d) {
+	int64_t next = (int64_t)d + 1;
+	if (N == 32) next += abs((int64_t)d) / 1024;
+	if (next == 0) next = 1;
+	return next > SINT_MAX ? 0 : (sint)next;
+}
+
+#define MAX_STEPS 1024
+
+// For every tested divisor d, step through dividends with several positive
+// and negative strides from several starting points, and compare with n / d
+// and n % d until the dividend leaves S_N or MAX_STEPS steps are taken.
+void test_strides() {
+	for (sint d = SINT_MIN; d != 0; d = next_divisor(d)) {
+		sdivdata_t dd = precompute_signed(d);
+		int64_t dabs = abs((int64_t)d);
+		int64_t strides[] = { 1, 2, 3, 7, dabs - 1, dabs, dabs + 1, 2 * dabs + 1, SINT_MAX };
+		int64_t starts[] = { SINT_MIN, -dabs - 1, -1, 0, dabs - 1, SINT_MAX };
+
+		for (int64_t stride : strides) {
+			for (int sign = -1; sign <= 1; sign += 2) {
+				if (stride == 0 || stride > SINT_MAX) continue;
+				for (int64_t start : starts) {
+					if (start < SINT_MIN || start > SINT_MAX) continue;
+					sdiviter_t it = signed_iterator(d, dd, start, sign * stride);
+					int64_t n = start;
+					for (int step = 0; n >= SINT_MIN && n <= SINT_MAX && step < MAX_STEPS; step++) {
+						// The quotient SINT_MIN / -1 does not fit in sint
+						if (!(d == -1 && n == SINT_MIN)) {
+							assert(signed_iterator_quotient(&it) == (sint)n / d);
+							assert(signed_iterator_remainder(&it) == (sint)n % d);
+						}
+						signed_iterator_next(&it);
+						n += sign * stride;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Test that seeking to arbitrary dividends re-synchronizes the iterator,
+// and that the block form produces the same values as stepping.
+void test_seek() {
+	uint32_t state = 12345;
+	for (sint d = SINT_MIN; d != 0; d = next_divisor(d)) {
+		if (d == -1) continue;
+		sdivdata_t dd = precompute_signed(d);
+		state = state * 1664525 + 1013904223;
+		sint stride = (sint)(state >> (32 - N)) | 1;
+		sdiviter_t it = signed_iterator(d, dd, 0, stride);
+
+		for (int jump = 0; jump < 16; jump++) {
+			state = state * 1664525 + 1013904223;
+			sint n = (sint)(state >> (32 - N));
+			signed_iterator_seek(&it, n);
+			assert(signed_iterator_quotient(&it) == n / d);
+			assert(signed_iterator_remainder(&it) == n % d);
+
+			sint quotients[37], remainders[37];
+			signed_iterator_fill(&it, quotients, remainders, 37);
+			for (int i = 0; i < 37; i++) {
+				int64_t m = (int64_t)n + (int64_t)i * stride;
+				if (m < SINT_MIN || m > SINT_MAX) break;
+				assert(quotients[i] == (sint)m / d);
+				assert(remainders[i] == (sint)m % d);
+			}
+		}
+	}
+}
+
+// Compare the time per quotient of hardware division, fast division, the
+// iterator, and the block form of the iterator, when scanning consecutive
+// dividends as in 'for n = -scan_length / 2..scan_length / 2: sum += n / d'.
+void benchmark() {
+	volatile sint divisor_source = -7;
+	const sint divisor = divisor_source;
+	const int32_t half_scan = N < 20 ? SINT_MAX : (1 << 19) - 1;
+	const int32_t scans = (1 << 26) / (2 * (int64_t)half_scan + 1);
+	const double divisions = 1.0 * scans * (2 * (int64_t)half_scan + 1);
+	sdivdata_t dd = precompute_signed(divisor);
+
+	int64_t reference_sum = 0, reference_start = get_nanoseconds();
+	for (int32_t s = 0; s < scans; s++)
+		for (int32_t n = -half_scan; n <= half_scan; n++)
+			reference_sum += (sint)n / divisor;
+	uint64_t reference_end = get_nanoseconds();
+	printf("Standard division took %.3f nanoseconds per division\n", (reference_end - reference_start) / divisions);
+
+	int64_t fast_sum = 0, fast_start = get_nanoseconds();
+	for (int32_t s = 0; s < scans; s++)
+		for (int32_t n = -half_scan; n <= half_scan; n++)
+			fast_sum += fast_signed_divide(n, dd);
+	uint64_t fast_end = get_nanoseconds();
+	printf("Fast division took %.3f nanoseconds per division\n", (fast_end - fast_start) / divisions);
+
+	int64_t iterator_sum = 0, iterator_start = get_nanoseconds();
+	for (int32_t s = 0; s < scans; s++) {
+		sdiviter_t it = signed_iterator(divisor, dd, -half_scan, 1);
+		for (int32_t n = -half_scan; n <= half_scan; n++) {
+			iterator_sum += signed_iterator_quotient(&it);
+			signed_iterator_next(&it);
+		}
+	}
+	uint64_t iterator_end = get_nanoseconds();
+	printf("Iterator took %.3f nanoseconds per division\n", (iterator_end - iterator_start) / divisions);
+
+	const size_t block_size = 256;
+	sint block[block_size];
+	int64_t block_sum = 0, block_start = get_nanoseconds();
+	for (int32_t s = 0; s < scans; s++) {
+		sdiviter_t it = signed_iterator(divisor, dd, -half_scan, 1);
+		for (int64_t n = -half_scan; n <= half_scan; n += block_size) {
+			size_t count = half_scan - n + 1 < (int64_t)block_size ? half_scan - n + 1 : block_size;
+			signed_iterator_fill(&it, block, NULL, count);
+			for (size_t i = 0; i < count; i++)
+				block_sum += block[i];
+		}
+	}
+	uint64_t block_end = get_nanoseconds();
+	printf("Iterator block form took %.3f nanoseconds per division\n", (block_end - block_start) / divisions);
+
+	assert(fast_sum == reference_sum);
+	assert(iterator_sum == reference_sum);
+	assert(block_sum == reference_sum);
+}
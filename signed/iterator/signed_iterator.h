@@ -0,0 +1,117 @@
+#ifndef SIGNED_ITERATOR_H
+#define SIGNED_ITERATOR_H
+
+#include <stddef.h>
+#include "../../common/bits.h"
+#include "../runtime/signed_division.h"
+
+// Quotient and remainder of the dividends n, n + stride, n + 2 * stride, ...
+// divided by d, where stride may be negative. Internally, the iterator keeps
+// the quotient rounded down and the non-negative remainder of the division by
+// |d|, because these can be stepped with additions and a comparison, also
+// when the dividends cross zero. They are converted to the quotient rounded
+// toward zero and the remainder with the sign of the dividend when read.
+typedef struct {
+	sint d;
+	sdivdata_t dd;
+	uint dabs;
+	sint n, stride;
+	sint stride_quotient;
+	uint stride_remainder;
+	uint wrap; // |d| - stride_remainder
+	sint floor_quotient;
+	uint floor_remainder;
+} sdiviter_t;
+
+sdiviter_t signed_iterator(sint d, sdivdata_t dd, sint n, sint stride);
+void signed_iterator_seek(sdiviter_t *it, sint n);
+void signed_iterator_next(sdiviter_t *it);
+sint signed_iterator_quotient(const sdiviter_t *it);
+sint signed_iterator_remainder(const sdiviter_t *it);
+void signed_iterator_fill(sdiviter_t *it, sint *quotients, sint *remainders, size_t count);
+
+// Compute floor(n / |d|) and the corresponding remainder in [0, |d|).
+void signed_floor_divide(sint n, sdivdata_t dd, uint dabs, sint *quotient, uint *remainder) {
+	// The quotient rounded toward zero of n / |d|. This is done in uint
+	// arithmetic, so that -SINT_MIN wraps around to SINT_MIN (which is
+	// the correct value of SINT_MIN / 1) instead of overflowing.
+	uint q = ((uint)fast_signed_divide(n, dd) ^ (uint)dd.exor) - (uint)dd.exor;
+	sint r = (sint)((uint)n - q * dabs);
+	if (r < 0) {
+		q--;
+		r += dabs;
+	}
+	*quotient = (sint)q;
+	*remainder = (uint)r;
+}
+
+// Create an iterator over the dividends n, n + stride, n + 2 * stride, ...
+// where dd = precompute_signed(d). The iterator is positioned at n.
+sdiviter_t signed_iterator(sint d, sdivdata_t dd, sint n, sint stride) {
+	sdiviter_t it;
+	it.d = d;
+	it.dd = dd;
+	it.dabs = d < 0 ? -(uint)d : d;
+	it.stride = stride;
+	signed_floor_divide(stride, dd, it.dabs, &it.stride_quotient, &it.stride_remainder);
+	it.wrap = it.dabs - it.stride_remainder;
+	signed_iterator_seek(&it, n);
+	return it;
+}
+
+// Jump to an arbitrary dividend n, using a single fast division.
+void signed_iterator_seek(sdiviter_t *it, sint n) {
+	it->n = n;
+	signed_floor_divide(n, it->dd, it->dabs, &it->floor_quotient, &it->floor_remainder);
+}
+
+// Advance to the next dividend. This is the same as for unsigned_iterator_next,
+// since the remainders are both in [0, |d|). The additions are done in uint
+// arithmetic so that stepping past the end of the range wraps around instead
+// of overflowing.
+void signed_iterator_next(sdiviter_t *it) {
+	it->n = (sint)((uint)it->n + (uint)it->stride);
+	uint q = it->floor_quotient;
+	if (it->floor_remainder >= it->wrap) {
+		it->floor_remainder -= it->wrap;
+		q += (uint)it->stride_quotient + 1;
+	}
+	else {
+		it->floor_remainder += it->stride_remainder;
+		q += (uint)it->stride_quotient;
+	}
+	it->floor_quotient = (sint)q;
+}
+
+// Returns n / d for the current dividend n.
+sint signed_iterator_quotient(const sdiviter_t *it) {
+	// For negative n with a nonzero remainder, rounding toward zero is one more than rounding down
+	uint q = (uint)it->floor_quotient + (it->n < 0 && it->floor_remainder != 0);
+	return (sint)((q ^ (uint)it->dd.exor) - (uint)it->dd.exor);
+}
+
+// Returns n % d for the current dividend n.
+sint signed_iterator_remainder(const sdiviter_t *it) {
+	if (it->n < 0 && it->floor_remainder != 0)
+		return (sint)(it->floor_remainder - it->dabs);
+	return (sint)it->floor_remainder;
+}
+
+// Store the quotients and remainders of the next count dividends, starting at
+// the current one, and leave the iterator positioned after them. remainders
+// may be NULL if only the quotients are needed. This costs the same steps as
+// signed_iterator_next plus the stores, so a loop that uses each quotient
+// right away is faster stepping the iterator itself.
+void signed_iterator_fill(sdiviter_t *it, sint *quotients, sint *remainders, size_t count) {
+	// Work on a local copy, since the stores to quotients and remainders
+	// could otherwise alias the fields of *it and force them to be reloaded.
+	sdiviter_t local = *it;
+	for (size_t i = 0; i < count; i++) {
+		quotients[i] = signed_iterator_quotient(&local);
+		if (remainders) remainders[i] = signed_iterator_remainder(&local);
+		signed_iterator_next(&local);
+	}
+	*it = local;
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef SIGNED_DIVISION_H
 #define SIGNED_DIVISION_H
 
+#include <stddef.h>
 #include "../../common/bits.h"
 
 typedef struct {
@@ -13,6 +14,7 @@ typedef struct {
 
 sdivdata_t precompute_signed(sint d);
 sint fast_signed_divide(sint n, sdivdata_t dd);
+void fast_signed_divide_batch(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sdivdata_t dd);
 
 // For a given n, evaluate +/- ((n * mul + add) >> (N + shift)) + (n >> (N - 1))
 // where add, mul, and shift are specified in divdata_t dd.
@@ -29,11 +31,19 @@ sint fast_signed_divide(sint n, sdivdata_t dd) {
 	return quotient_correct_sign;
 }
 
+// Compute q[i] = n[i] / d for 0 <= i < count, where n and q do not overlap.
+__attribute__((optimize("tree-vectorize")))
+void fast_signed_divide_batch(const sint *__restrict__ n, sint *__restrict__ q, size_t count, sdivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_signed_divide(n[i], dd);
+}
+
 // For a given divisor d in U_N, compute add, mul, shift such that
 // (n * mul + add) >> (N + shift) = n / d for all n in U_N.
 sdivdata_t precompute_signed(sint d) {
 	sdivdata_t divdata;
-	uint dabs = abs(d);
+	// Negate in uint arithmetic, since -SINT_MIN overflows sint
+	uint dabs = d < 0 ? -(uint)d : d;
 
 	// TODO: can we compute max(ceil_log2(|d|), 1) more efficiently?
 	uint l = floor_log2(dabs);
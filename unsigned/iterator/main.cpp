@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <time.h>
+
+#define N 8
+#include "../../common/bits.h"
+#include "unsigned_iterator.h"
+
+void test_strides();
+void test_seek();
+void benchmark();
+
+int main() {
+	printf("Testing iterators for %s %u-bit unsigned divisors. This might take a while...\n", N == 32 ? "a sample of the" : "all", N);
+	test_strides();
+	test_seek();
+	printf("Done!\n");
+	benchmark();
+	return 0;
+}
+
+uint64_t get_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Returns the divisor after d that is tested, or 0 if d is the last one.
+// For N == 32, not all divisors are tested, but small divisors are tested
+// exhaustively and large divisors are sampled over the whole range.
+uint next_divisor(uint d) {
+	big_uint next = (big_uint)d + 1;
+	if (N == 32) next += d / 1024;
+	return next > UINT_MAX ? 0 : (uint)next;
+}
+
+#define MAX_STEPS 1024
+
+// For every tested divisor d, step through dividends with several strides
+// from several starting points, and compare with n / d and n % d until the
+// dividend leaves U_N or MAX_STEPS steps are taken.
+void test_strides() {
+	for (uint d = 1; d != 0; d = next_divisor(d)) {
+		udivdata_t dd = precompute_unsigned(d);
+		uint64_t strides[] = { 1, 2, 3, 7, d - 1ull, d, d + 1ull, 2ull * d + 1, 1ull << (N - 1) };
+		uint64_t starts[] = { 0, d - 1ull, UINT_MAX / 3 };
+
+		for (uint64_t stride : strides) {
+			if (stride == 0 || stride > UINT_MAX) continue;
+			for (uint64_t start : starts) {
+				udiviter_t it = unsigned_iterator(d, dd, start, stride);
+				uint64_t n = start;
+				for (int step = 0; n <= UINT_MAX && step < MAX_STEPS; step++) {
+					assert(it.quotient == (uint)n / d);
+					assert(it.remainder == (uint)n % d);
+					unsigned_iterator_next(&it);
+					n += stride;
+				}
+			}
+		}
+	}
+}
+
+// Test that seeking to arbitrary dividends re-synchronizes the iterator,
+// and that the block form produces the same values as stepping.
+void test_seek() {
+	uint32_t state = 12345;
+	for (uint d = 1; d != 0; d = next_divisor(d)) {
+		udivdata_t dd = precompute_unsigned(d);
+		state = state * 1664525 + 1013904223;
+		uint stride = (state >> (32 - N)) | 1;
+		udiviter_t it = unsigned_iterator(d, dd, 0, stride);
+
+		for (int jump = 0; jump < 16; jump++) {
+			state = state * 1664525 + 1013904223;
+			uint n = state >> (32 - N);
+			unsigned_iterator_seek(&it, n);
+			assert(it.quotient == n / d);
+			assert(it.remainder == n % d);
+
+			uint quotients[37], remainders[37];
+			unsigned_iterator_fill(&it, quotients, remainders, 37);
+			for (int i = 0; i < 37 && n + (uint64_t)i * stride <= UINT_MAX; i++) {
+				assert(quotients[i] == (uint)(n + i * stride) / d);
+				assert(remainders[i] == (uint)(n + i * stride) % d);
+			}
+		}
+	}
+}
+
+// Compare the time per quotient of hardware division, fast division, the
+// iterator, and the block form of the iterator, when scanning consecutive
+// dividends as in 'for n = 0..scan_length: sum += n / d'.
+void benchmark() {
+	volatile uint divisor_source = 7;
+	const uint divisor = divisor_source;
+	const uint32_t scan_length = N < 20 ? UINT_MAX : (1 << 20) - 1;
+	const uint32_t scans = (1 << 26) / (scan_length + 1ull);
+	const double divisions = 1.0 * scans * (scan_length + 1ull);
+	udivdata_t dd = precompute_unsigned(divisor);
+
+	uint64_t reference_sum = 0, reference_start = get_nanoseconds();
+	for (uint32_t s = 0; s < scans; s++)
+		for (uint32_t n = 0; n <= scan_length; n++)
+			reference_sum += (uint)n / divisor;
+	uint64_t reference_end = get_nanoseconds();
+	printf("Standard division took %.3f nanoseconds per division\n", (reference_end - reference_start) / divisions);
+
+	uint64_t fast_sum = 0, fast_start = get_nanoseconds();
+	for (uint32_t s = 0; s < scans; s++)
+		for (uint32_t n = 0; n <= scan_length; n++)
+			fast_sum += fast_unsigned_divide(n, dd);
+	uint64_t fast_end = get_nanoseconds();
+	printf("Fast division took %.3f nanoseconds per division\n", (fast_end - fast_start) / divisions);
+
+	uint64_t iterator_sum = 0, iterator_start = get_nanoseconds();
+	for (uint32_t s = 0; s < scans; s++) {
+		udiviter_t it = unsigned_iterator(divisor, dd, 0, 1);
+		for (uint32_t n = 0; n <= scan_length; n++) {
+			iterator_sum += it.quotient;
+			unsigned_iterator_next(&it);
+		}
+	}
+	uint64_t iterator_end = get_nanoseconds();
+	printf("Iterator took %.3f nanoseconds per division\n", (iterator_end - iterator_start) / divisions);
+
+	const size_t block_size = 256;
+	uint block[block_size];
+	uint64_t block_sum = 0, block_start = get_nanoseconds();
+	for (uint32_t s = 0; s < scans; s++) {
+		udiviter_t it = unsigned_iterator(divisor, dd, 0, 1);
+		for (uint64_t n = 0; n <= scan_length; n += block_size) {
+			size_t count = scan_length - n + 1 < block_size ? scan_length - n + 1 : block_size;
+			unsigned_iterator_fill(&it, block, NULL, count);
+			for (size_t i = 0; i < count; i++)
+				block_sum += block[i];
+		}
+	}
+	uint64_t block_end = get_nanoseconds();
+	printf("Iterator block form took %.3f nanoseconds per division\n", (block_end - block_start) / divisions);
+
+	assert(fast_sum == reference_sum);
+	assert(iterator_sum == reference_sum);
+	assert(block_sum == reference_sum);
+}
@@ -0,0 +1,75 @@
+#ifndef UNSIGNED_ITERATOR_H
+#define UNSIGNED_ITERATOR_H
+
+#include <stddef.h>
+#include "../../common/bits.h"
+#include "../runtime/unsigned_division.h"
+
+// Quotient and remainder of the dividends n, n + stride, n + 2 * stride, ...
+// divided by d. Only the first dividend (and every seek) needs a division;
+// stepping to the next dividend is done with additions and a comparison.
+typedef struct {
+	uint d;
+	udivdata_t dd;
+	uint stride_quotient, stride_remainder;
+	uint wrap; // d - stride_remainder
+	uint quotient, remainder;
+} udiviter_t;
+
+udiviter_t unsigned_iterator(uint d, udivdata_t dd, uint n, uint stride);
+void unsigned_iterator_seek(udiviter_t *it, uint n);
+void unsigned_iterator_next(udiviter_t *it);
+void unsigned_iterator_fill(udiviter_t *it, uint *quotients, uint *remainders, size_t count);
+
+// Create an iterator over the dividends n, n + stride, n + 2 * stride, ...
+// where dd = precompute_unsigned(d). The iterator is positioned at n.
+udiviter_t unsigned_iterator(uint d, udivdata_t dd, uint n, uint stride) {
+	udiviter_t it;
+	it.d = d;
+	it.dd = dd;
+	it.stride_quotient = fast_unsigned_divide(stride, dd);
+	it.stride_remainder = stride - it.stride_quotient * d;
+	it.wrap = d - it.stride_remainder;
+	unsigned_iterator_seek(&it, n);
+	return it;
+}
+
+// Jump to an arbitrary dividend n, using a single fast division.
+void unsigned_iterator_seek(udiviter_t *it, uint n) {
+	it->quotient = fast_unsigned_divide(n, it->dd);
+	it->remainder = n - it->quotient * it->d;
+}
+
+// Advance to the next dividend. Since both remainders are less than d, their
+// sum is less than 2 * d, so at most one carry into the quotient is needed.
+// Comparing against wrap = d - stride_remainder instead of computing the sum
+// first avoids overflow when d > UINT_MAX / 2.
+void unsigned_iterator_next(udiviter_t *it) {
+	if (it->remainder >= it->wrap) {
+		it->remainder -= it->wrap;
+		it->quotient += it->stride_quotient + 1;
+	}
+	else {
+		it->remainder += it->stride_remainder;
+		it->quotient += it->stride_quotient;
+	}
+}
+
+// Store the quotients and remainders of the next count dividends, starting at
+// the current one, and leave the iterator positioned after them. remainders
+// may be NULL if only the quotients are needed. This costs the same steps as
+// unsigned_iterator_next plus the stores, so a loop that uses each quotient
+// right away is faster stepping the iterator itself.
+void unsigned_iterator_fill(udiviter_t *it, uint *quotients, uint *remainders, size_t count) {
+	// Work on a local copy, since the stores to quotients and remainders
+	// could otherwise alias the fields of *it and force them to be reloaded.
+	udiviter_t local = *it;
+	for (size_t i = 0; i < count; i++) {
+		quotients[i] = local.quotient;
+		if (remainders) remainders[i] = local.remainder;
+		unsigned_iterator_next(&local);
+	}
+	*it = local;
+}
+
+#endif
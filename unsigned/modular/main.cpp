@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <time.h>
+
+#define N 8
+#include "../../common/bits.h"
+#include "modular.h"
+
+void test_exhaustive();
+void test_sampled();
+void test_powmod();
+void benchmark();
+
+int main() {
+#if N == 8
+	printf("Testing all %u-bit moduli and operands. This might take a while...\n", N);
+	test_exhaustive();
+#else
+	printf("Testing %s %u-bit moduli and first operands. This might take a while...\n", N == 32 ? "a sample of the" : "all", N);
+	test_sampled();
+#endif
+	test_powmod();
+	printf("Done!\n");
+	benchmark();
+	return 0;
+}
+
+uint64_t get_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Test a, b against (a + b) % d and (a * b) % d, and in Montgomery form for odd d.
+void test_operands(uint a, uint b, umoddata_t md, umontdata_t mont) {
+	uint d = md.d;
+	assert(addmod(a, b, md) == ((big_uint)a + b) % d);
+	assert(mulmod(a, b, md) == ((big_uint)a * b) % d);
+	if (d & 1) {
+		uint a_mont = to_montgomery(a, mont), b_mont = to_montgomery(b, mont);
+		assert(from_montgomery(montgomery_multiply(a_mont, b_mont, mont), mont) == ((big_uint)a * b) % d);
+	}
+}
+
+// For all d in U_N with d > 0, test reduce_modular for all x < d * 2^N, and
+// all operations for all a, b < d.
+void test_exhaustive() {
+	for (uint d = 1; true; d++) {
+		umoddata_t md = precompute_modulus(d);
+		umontdata_t mont = d & 1 ? precompute_montgomery(d) : umontdata_t();
+
+		for (big_uint x = 0; x < (big_uint)d << N; x++)
+			assert(reduce_modular(x, md) == x % d);
+
+		for (uint a = 0; a < d; a++) {
+			if (d & 1) {
+				assert(to_montgomery(a, mont) == ((big_uint)a << N) % d);
+				assert(from_montgomery(to_montgomery(a, mont), mont) == a);
+			}
+			for (uint b = 0; b < d; b++)
+				test_operands(a, b, md, mont);
+		}
+		if (d == UINT_MAX) break;
+	}
+}
+
+// For all d in U_N with d > 0, test all operations for all a < d, with
+// values of b that include the boundaries and pseudo-random values.
+// Testing all pairs a, b is not feasible for N > 8.
+void test_sampled() {
+	uint32_t state = 12345;
+	// For N == 32, small values are tested exhaustively, and large values are
+	// sampled over the whole range.
+	for (uint64_t d = 1; d <= UINT_MAX; d += N == 32 ? 1 + d / 1024 : 1) {
+		umoddata_t md = precompute_modulus(d);
+		umontdata_t mont = d & 1 ? precompute_montgomery(d) : umontdata_t();
+
+		for (uint64_t a = 0; a < d; a += N == 32 ? 1 + a / 64 : 1) {
+			if (d & 1) assert(from_montgomery(to_montgomery(a, mont), mont) == a);
+			state = state * 1664525 + 1013904223;
+			uint b_values[] = { 0, 1, (uint)(d - 1), (uint)(d / 2), (uint)a, (uint)(state % d) };
+			for (uint b : b_values)
+				test_operands(a, b, md, mont);
+		}
+	}
+}
+
+// Test powmod against repeated multiplication for small exponents, and
+// against Fermat's little theorem for prime moduli and large exponents.
+void test_powmod() {
+	uint moduli[] = { 1, 2, 3, 7, 10, 101, (uint)(UINT_MAX - 4), UINT_MAX };
+	for (uint d : moduli) {
+		umoddata_t md = precompute_modulus(d);
+		for (uint a = 0; a < d && a < 300; a++) {
+			big_uint expected = 1 % d;
+			for (uint64_t e = 0; e < 64; e++) {
+				assert(powmod(a, e, md) == expected);
+				expected = expected * a % d;
+			}
+		}
+	}
+
+	// 251, 65521 and 4294967291 are the largest primes below 2^8, 2^16 and 2^32
+	uint p = N == 8 ? 251 : N == 16 ? 65521 : 4294967291u;
+	umoddata_t md = precompute_modulus(p);
+	for (uint a = 1; a < p && a < 1000; a++)
+		assert(powmod(a, p - 1, md) == 1);
+}
+
+// Compare the time per multiplication of (a * b) % d with hardware division,
+// mulmod_batch and montgomery_multiply_batch.
+void benchmark() {
+	volatile uint modulus_source = N == 8 ? 251 : N == 16 ? 65521 : 4294967291u;
+	const uint d = modulus_source;
+	const size_t count = 1 << 16;
+	const int repetitions = 256;
+	const double multiplications = 1.0 * repetitions * count;
+	umoddata_t md = precompute_modulus(d);
+	umontdata_t mont = precompute_montgomery(d);
+
+	static uint a[1 << 16], b[1 << 16], product[1 << 16];
+	uint32_t state = 12345;
+	for (size_t i = 0; i < count; i++) {
+		state = state * 1664525 + 1013904223;
+		a[i] = (state >> (32 - N)) % d;
+		state = state * 1664525 + 1013904223;
+		b[i] = (state >> (32 - N)) % d;
+	}
+
+	uint64_t reference_sum = 0, reference_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		for (size_t i = 0; i < count; i++)
+			product[i] = ((big_uint)a[i] * b[i]) % d;
+		reference_sum += product[r];
+	}
+	uint64_t reference_end = get_nanoseconds();
+	printf("Standard division took %.3f nanoseconds per multiplication\n", (reference_end - reference_start) / multiplications);
+
+	uint64_t fast_sum = 0, fast_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		mulmod_batch(a, b, product, count, md);
+		fast_sum += product[r];
+	}
+	uint64_t fast_end = get_nanoseconds();
+	printf("mulmod_batch took %.3f nanoseconds per multiplication\n", (fast_end - fast_start) / multiplications);
+
+	// Only the multiplications are timed, a and b are converted in advance
+	static uint a_mont[1 << 16], b_mont[1 << 16];
+	for (size_t i = 0; i < count; i++) {
+		a_mont[i] = to_montgomery(a[i], mont);
+		b_mont[i] = to_montgomery(b[i], mont);
+	}
+	uint64_t montgomery_sum = 0, montgomery_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		montgomery_multiply_batch(a_mont, b_mont, product, count, mont);
+		montgomery_sum += from_montgomery(product[r], mont);
+	}
+	uint64_t montgomery_end = get_nanoseconds();
+	printf("montgomery_multiply_batch took %.3f nanoseconds per multiplication\n", (montgomery_end - montgomery_start) / multiplications);
+
+	assert(fast_sum == reference_sum);
+	assert(montgomery_sum == reference_sum);
+}
@@ -0,0 +1,164 @@
+#ifndef MODULAR_H
+#define MODULAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../common/bits.h"
+
+// Data to reduce 2N-bit values modulo a constant d. The divisor is shifted
+// left until its most significant bit is set, and the reciprocal is the N + 1
+// bit magic number floor((2^(2N) - 1) / d_norm) without its leading one.
+typedef struct {
+	uint d;
+	uint shift;
+	uint d_norm;
+	uint reciprocal;
+} umoddata_t;
+
+// Data for Montgomery multiplication modulo an odd constant d, where a is
+// represented by a * 2^N mod d.
+typedef struct {
+	uint d;
+	uint inverse;  // d^-1 mod 2^N
+	uint r2;       // 2^(2N) mod d
+} umontdata_t;
+
+umoddata_t precompute_modulus(uint d);
+uint reduce_modular(big_uint x, umoddata_t md);
+uint addmod(uint a, uint b, umoddata_t md);
+uint mulmod(uint a, uint b, umoddata_t md);
+uint powmod(uint a, uint64_t e, umoddata_t md);
+void mulmod_batch(const uint *__restrict__ a, const uint *__restrict__ b, uint *__restrict__ product, size_t count, umoddata_t md);
+
+umontdata_t precompute_montgomery(uint d);
+uint montgomery_reduce(big_uint x, umontdata_t md);
+uint to_montgomery(uint a, umontdata_t md);
+uint from_montgomery(uint a, umontdata_t md);
+uint montgomery_multiply(uint a, uint b, umontdata_t md);
+void montgomery_multiply_batch(const uint *__restrict__ a, const uint *__restrict__ b, uint *__restrict__ product, size_t count, umontdata_t md);
+
+
+// For a given modulus d in U_N with d > 0, compute the normalized divisor and
+// its reciprocal. This does not build on precompute_unsigned: its magic
+// numbers give exact quotients only for N-bit dividends, and making them exact
+// for the 2N-bit products here would take a 2N-bit magic number and a 3N-bit
+// product. Instead, the reciprocal is only used for an estimate of the
+// quotient, which reduce_modular corrects afterwards.
+umoddata_t precompute_modulus(uint d) {
+	umoddata_t md;
+	md.d = d;
+	md.shift = N - 1 - floor_log2(d);
+	md.d_norm = d << md.shift;
+	md.reciprocal = ((big_uint)-1) / md.d_norm - (((big_uint)1) << N);
+	return md;
+}
+
+// Compute x mod d for x < d * 2^N, which includes all products of two values
+// less than d. This is the division of a 2N-bit value by an N-bit value with
+// a precomputed reciprocal by Möller and Granlund: the reciprocal gives an
+// estimate of the quotient which is at most one too large or too small, and
+// the remainder is computed from it and corrected.
+uint reduce_modular(big_uint x, umoddata_t md) {
+	// Shifting preserves the quotient, and the remainder is shifted too
+	x <<= md.shift;
+	uint u1 = x >> N, u0 = x;
+
+	// Estimate the quotient as (u1 * reciprocal + x) >> N, plus one
+	big_uint estimate = (big_uint)((big_uint)md.reciprocal * u1 + x);
+	uint q1 = (uint)(estimate >> N) + 1;
+	uint q0 = estimate;
+
+	// The products of two uints are computed as big_uint, because for N == 16
+	// they would be promoted to int, which can overflow.
+	uint r = u0 - (uint)((big_uint)q1 * md.d_norm);
+	if (r > q0) r += md.d_norm;
+	if (r >= md.d_norm) r -= md.d_norm;
+	return r >> md.shift;
+}
+
+// Compute (a + b) mod d for a, b < d. The comparison with d - b avoids
+// overflow when d > UINT_MAX / 2.
+uint addmod(uint a, uint b, umoddata_t md) {
+	return a >= md.d - b ? a - (md.d - b) : a + b;
+}
+
+// Compute (a * b) mod d for a, b < d.
+uint mulmod(uint a, uint b, umoddata_t md) {
+	return reduce_modular((big_uint)a * b, md);
+}
+
+// Compute a^e mod d for a < d by repeated squaring.
+uint powmod(uint a, uint64_t e, umoddata_t md) {
+	uint result = reduce_modular(1, md);
+	while (e) {
+		if (e & 1) result = mulmod(result, a, md);
+		a = mulmod(a, a, md);
+		e >>= 1;
+	}
+	return result;
+}
+
+// Compute product[i] = (a[i] * b[i]) mod d for 0 <= i < count, where product
+// does not overlap a or b. The two corrections in reduce_modular become
+// selects, so the loop body has no branches.
+__attribute__((optimize("tree-vectorize")))
+void mulmod_batch(const uint *__restrict__ a, const uint *__restrict__ b, uint *__restrict__ product, size_t count, umoddata_t md) {
+	for (size_t i = 0; i < count; i++)
+		product[i] = mulmod(a[i], b[i], md);
+}
+
+// For a given odd modulus d in U_N, compute the inverse of d modulo 2^N and
+// the factor to convert to Montgomery form.
+umontdata_t precompute_montgomery(uint d) {
+	assert(d & 1);
+	umontdata_t md;
+	md.d = d;
+
+	// Newton's iteration doubles the number of correct low bits, and
+	// d * d = 1 mod 8 for odd d, so d is correct in the lowest 3 bits.
+	uint inverse = d;
+	for (int bits = 3; bits < N; bits *= 2)
+		inverse = (big_uint)inverse * (uint)(2 - (uint)((big_uint)d * inverse));
+	md.inverse = inverse;
+
+	uint r = (((big_uint)1) << N) % d;
+	md.r2 = ((big_uint)r * r) % d;
+	return md;
+}
+
+// Compute x * 2^-N mod d for x < d * 2^N. m = x * d^-1 mod 2^N is chosen such
+// that the lower N bits of x and m * d are equal, so (x - m * d) / 2^N is the
+// difference of the upper halves, which is in (-d, d).
+uint montgomery_reduce(big_uint x, umontdata_t md) {
+	uint m = (big_uint)(uint)x * md.inverse;
+	uint x_high = x >> N;
+	uint t_high = ((big_uint)m * md.d) >> N;
+	uint r = x_high - t_high;
+	return x_high < t_high ? r + md.d : r;
+}
+
+// Convert a < d to Montgomery form a * 2^N mod d.
+uint to_montgomery(uint a, umontdata_t md) {
+	return montgomery_reduce((big_uint)a * md.r2, md);
+}
+
+// Convert a from Montgomery form back to the ordinary representation.
+uint from_montgomery(uint a, umontdata_t md) {
+	return montgomery_reduce(a, md);
+}
+
+// Compute the product of a and b in Montgomery form, so both the operands
+// and the result are in Montgomery form.
+uint montgomery_multiply(uint a, uint b, umontdata_t md) {
+	return montgomery_reduce((big_uint)a * b, md);
+}
+
+// Compute product[i] = montgomery_multiply(a[i], b[i]) for 0 <= i < count,
+// where product does not overlap a or b.
+__attribute__((optimize("tree-vectorize")))
+void montgomery_multiply_batch(const uint *__restrict__ a, const uint *__restrict__ b, uint *__restrict__ product, size_t count, umontdata_t md) {
+	for (size_t i = 0; i < count; i++)
+		product[i] = montgomery_multiply(a[i], b[i], md);
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef UNSIGNED_DIVISION_H
 #define UNSIGNED_DIVISION_H
 
+#include <stddef.h>
 #include "../../common/bits.h"
 
 typedef struct {
@@ -9,6 +10,7 @@ typedef struct {
 
 udivdata_t precompute_unsigned(uint d);
 uint fast_unsigned_divide(uint n, udivdata_t dd);
+void fast_unsigned_divide_batch(const uint *__restrict__ n, uint *__restrict__ q, size_t count, udivdata_t dd);
 
 // For a given n, evaluate (n * mul + add) >> (N + shift),
 // where add, mul, and shift are specified in udivdata_t dd.
@@ -17,6 +19,13 @@ uint fast_unsigned_divide(uint n, udivdata_t dd) {
 	return (full_product >> N) >> dd.shift;
 }
 
+// Compute q[i] = n[i] / d for 0 <= i < count, where n and q do not overlap.
+__attribute__((optimize("tree-vectorize")))
+void fast_unsigned_divide_batch(const uint *__restrict__ n, uint *__restrict__ q, size_t count, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++)
+		q[i] = fast_unsigned_divide(n[i], dd);
+}
+
 // For a given divisor d in U_N, compute add, mul, shift such that
 // (n * mul + add) >> (N + shift) = n / d for all n in U_N.
 udivdata_t precompute_unsigned(uint d) {
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define N 8
+#include "../../common/bits.h"
+#include "swar_division.h"
+
+void test_exhaustive();
+void test_batch();
+void benchmark();
+
+int main() {
+	printf("Testing all %u-bit unsigned integers in %u lanes. This might take a while...\n", N, SWAR_LANES);
+	test_exhaustive();
+	test_batch();
+	printf("Done!\n");
+	benchmark();
+	return 0;
+}
+
+uint64_t get_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Test quotient n/d for all n, d in U_N with d > 0. Every lane gets a
+// different dividend, so each dividend is tested in every lane.
+void test_exhaustive() {
+	for (uint d = 1; true; d++) {
+		udivdata_t dd = precompute_unsigned(d);
+		for (uint n = 0; true; n++) {
+			uint lanes[SWAR_LANES], quotients[SWAR_LANES];
+			for (int k = 0; k < SWAR_LANES; k++)
+				lanes[k] = n + k;
+
+			uint64_t word;
+			memcpy(&word, lanes, sizeof(word));
+			word = swar_unsigned_divide(word, dd);
+			memcpy(quotients, &word, sizeof(word));
+
+			for (int k = 0; k < SWAR_LANES; k++)
+				assert(quotients[k] == fast_unsigned_divide(lanes[k], dd));
+			if (n == UINT_MAX) break;
+		}
+		if (d == UINT_MAX) break;
+	}
+}
+
+// Test the batch form with counts that are not a multiple of SWAR_LANES,
+// and with unaligned arrays.
+void test_batch() {
+	static uint n[1000], q[1000];
+	for (size_t i = 0; i < 1000; i++)
+		n[i] = i * 2654435761u;
+
+	for (uint d = 1; true; d++) {
+		udivdata_t dd = precompute_unsigned(d);
+		for (size_t offset = 0; offset < 3; offset++) {
+			size_t count = 1000 - 3 - offset;
+			swar_unsigned_divide_batch(n + offset, q + offset, count, dd);
+			for (size_t i = offset; i < offset + count; i++)
+				assert(q[i] == n[i] / d);
+		}
+		if (d == UINT_MAX) break;
+	}
+}
+
+// Compare the time per division of hardware division, fast division
+// and SWAR division on a buffer of pseudo-random dividends.
+void benchmark() {
+	volatile uint divisor_source = 7;
+	const uint divisor = divisor_source;
+	const size_t count = 1 << 16;
+	const int repetitions = 256;
+	const double divisions = 1.0 * repetitions * count;
+	udivdata_t dd = precompute_unsigned(divisor);
+
+	static uint n[1 << 16], q[1 << 16];
+	uint32_t state = 12345;
+	for (size_t i = 0; i < count; i++) {
+		state = state * 1664525 + 1013904223;
+		n[i] = state >> (32 - N);
+	}
+
+	uint64_t reference_sum = 0, reference_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		for (size_t i = 0; i < count; i++)
+			q[i] = n[i] / divisor;
+		reference_sum += q[r];
+	}
+	uint64_t reference_end = get_nanoseconds();
+	printf("Standard division took %.3f nanoseconds per division\n", (reference_end - reference_start) / divisions);
+
+	uint64_t fast_sum = 0, fast_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		// Not fast_unsigned_divide_batch, which is vectorized regardless of
+		// -fno-tree-vectorize
+		for (size_t i = 0; i < count; i++)
+			q[i] = fast_unsigned_divide(n[i], dd);
+		fast_sum += q[r];
+	}
+	uint64_t fast_end = get_nanoseconds();
+	printf("Fast division took %.3f nanoseconds per division\n", (fast_end - fast_start) / divisions);
+
+	uint64_t swar_sum = 0, swar_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		swar_unsigned_divide_batch(n, q, count, dd);
+		swar_sum += q[r];
+	}
+	uint64_t swar_end = get_nanoseconds();
+	printf("SWAR division took %.3f nanoseconds per division\n", (swar_end - swar_start) / divisions);
+
+	assert(fast_sum == reference_sum);
+	assert(swar_sum == reference_sum);
+}
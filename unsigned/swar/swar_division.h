@@ -0,0 +1,64 @@
+#ifndef SWAR_DIVISION_H
+#define SWAR_DIVISION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../common/bits.h"
+#include "../runtime/unsigned_division.h"
+
+// SIMD within a register: divide the N-bit lanes of a uint64_t at once, using
+// only general purpose registers. The even and odd lanes are handled
+// separately, so that every lane has a 2N-bit slot for its product.
+#if N == 8
+#define SWAR_LANES 8
+#define SWAR_SLOT_MASK 0x00ff00ff00ff00ffull
+#define SWAR_SLOT_ONES 0x0001000100010001ull
+#elif N == 16
+#define SWAR_LANES 4
+#define SWAR_SLOT_MASK 0x0000ffff0000ffffull
+#define SWAR_SLOT_ONES 0x0000000100000001ull
+#else
+#error SWAR division is only supported for N == 8 and N == 16.
+#endif
+
+uint64_t swar_divide_slots(uint64_t n, udivdata_t dd);
+uint64_t swar_unsigned_divide(uint64_t n, udivdata_t dd);
+void swar_unsigned_divide_batch(const uint *n, uint *q, size_t count, udivdata_t dd);
+
+// For a word n with an N-bit value in the lower half of every 2N-bit slot,
+// evaluate (n * mul + add) >> (N + shift) for every slot. Since
+// n * mul + add <= (2^N - 1) * (2^N - 1) + 2^N - 1 < 2^(2N), the product
+// of every slot fits in the slot, so a single 64-bit multiplication computes
+// the products of all slots without carries between them.
+uint64_t swar_divide_slots(uint64_t n, udivdata_t dd) {
+	uint64_t products = n * dd.mul + dd.add * SWAR_SLOT_ONES;
+	uint64_t high_halves = (products >> N) & SWAR_SLOT_MASK;
+	// The shift moves bits of the next slot into the upper half of every slot
+	return (high_halves >> dd.shift) & SWAR_SLOT_MASK;
+}
+
+// Divide each of the SWAR_LANES N-bit lanes of n by the divisor described by dd.
+uint64_t swar_unsigned_divide(uint64_t n, udivdata_t dd) {
+	uint64_t even = swar_divide_slots(n & SWAR_SLOT_MASK, dd);
+	uint64_t odd = swar_divide_slots((n >> N) & SWAR_SLOT_MASK, dd);
+	return even | (odd << N);
+}
+
+// Compute q[i] = n[i] / d for 0 <= i < count, SWAR_LANES elements at a time.
+// This is meant for targets without vector instructions; when they are
+// available, fast_unsigned_divide_batch vectorizes better. Whether it beats
+// the scalar loop depends on the CPU, so measure with main.cpp.
+void swar_unsigned_divide_batch(const uint *n, uint *q, size_t count, udivdata_t dd) {
+	size_t words = count / SWAR_LANES;
+	for (size_t w = 0; w < words; w++) {
+		uint64_t word;
+		memcpy(&word, n + w * SWAR_LANES, sizeof(word));
+		word = swar_unsigned_divide(word, dd);
+		memcpy(q + w * SWAR_LANES, &word, sizeof(word));
+	}
+	for (size_t i = words * SWAR_LANES; i < count; i++)
+		q[i] = fast_unsigned_divide(n[i], dd);
+}
+
+#endif
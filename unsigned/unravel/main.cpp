@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <time.h>
+
+#define N 8
+#include "../../common/bits.h"
+#include "unravel.h"
+
+void test_small_shapes(uint rank, uint *extents, uint dimension, uint64_t product);
+void test_large_shapes();
+void test_shape(const shape_t *shape, uint64_t product);
+void benchmark();
+
+// All shapes up to this rank, with at most this many elements, are tested.
+// For N == 8, this covers every shape of rank at most 4 that fits in U_8.
+#define TEST_RANK 4
+#define TEST_ELEMENTS (N == 8 ? 256 : 1024)
+
+int main() {
+	printf("Testing all shapes of rank at most %u with at most %u elements. This might take a while...\n", TEST_RANK, TEST_ELEMENTS);
+	uint extents[TEST_RANK];
+	for (uint rank = 1; rank <= TEST_RANK; rank++)
+		test_small_shapes(rank, extents, 0, 1);
+	test_large_shapes();
+	printf("Done!\n");
+	benchmark();
+	return 0;
+}
+
+uint64_t get_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Enumerate the extents of all shapes of the given rank with at most
+// TEST_ELEMENTS elements, and test each shape.
+void test_small_shapes(uint rank, uint *extents, uint dimension, uint64_t product) {
+	if (dimension == rank) {
+		shape_t shape = precompute_shape(rank, extents);
+		test_shape(&shape, product);
+		return;
+	}
+	for (uint64_t extent = 1; extent <= UINT_MAX && product * extent <= TEST_ELEMENTS; extent++) {
+		extents[dimension] = extent;
+		test_small_shapes(rank, extents, dimension + 1, product * extent);
+	}
+}
+
+// Test unravel_index, ravel_index and unravel_index_batch against / and %
+// for all indices of the shape that fit in U_N.
+void test_shape(const shape_t *shape, uint64_t product) {
+	static uint indices[TEST_ELEMENTS], batch[MAX_RANK][TEST_ELEMENTS];
+	uint *batch_coordinates[MAX_RANK];
+	for (uint k = 0; k < shape->rank; k++)
+		batch_coordinates[k] = batch[k];
+
+	size_t count = product - 1 > UINT_MAX ? (size_t)UINT_MAX + 1 : product;
+	if (count > TEST_ELEMENTS) count = TEST_ELEMENTS;
+	for (size_t i = 0; i < count; i++)
+		indices[i] = i;
+	unravel_index_batch(indices, count, shape, batch_coordinates);
+
+	for (size_t i = 0; i < count; i++) {
+		uint coordinates[MAX_RANK];
+		unravel_index(indices[i], shape, coordinates);
+
+		uint index = indices[i];
+		for (uint k = shape->rank - 1; k > 0; k--) {
+			assert(coordinates[k] == index % shape->extents[k]);
+			index /= shape->extents[k];
+		}
+		assert(coordinates[0] == index);
+
+		for (uint k = 0; k < shape->rank; k++)
+			assert(batch[k][i] == coordinates[k]);
+		assert(ravel_index(coordinates, shape) == indices[i]);
+	}
+}
+
+// Test shapes with extents up to UINT_MAX on pseudo-random indices.
+void test_large_shapes() {
+	uint32_t state = 12345;
+	for (int s = 0; s < 10000; s++) {
+		uint rank = 1 + s % MAX_RANK;
+		uint extents[MAX_RANK];
+		for (uint k = 0; k < rank; k++) {
+			state = state * 1664525 + 1013904223;
+			// Mix large extents and small ones
+			extents[k] = (state >> (32 - N)) >> (state % N);
+			if (extents[k] == 0) extents[k] = 1;
+		}
+		shape_t shape = precompute_shape(rank, extents);
+
+		for (int i = 0; i < 64; i++) {
+			state = state * 1664525 + 1013904223;
+			uint index = state >> (32 - N), coordinates[MAX_RANK];
+			unravel_index(index, &shape, coordinates);
+
+			uint remaining = index;
+			for (uint k = rank - 1; k > 0; k--) {
+				assert(coordinates[k] == remaining % extents[k]);
+				remaining /= extents[k];
+			}
+			assert(coordinates[0] == remaining);
+		}
+	}
+}
+
+// Compare unraveling all indices of a three-dimensional shape with / and %,
+// with unravel_index, and with unravel_index_batch.
+void benchmark() {
+	volatile uint extent_source[3] = { 3, 5, 7 };
+	const uint extents[3] = { extent_source[0], extent_source[1], extent_source[2] };
+	const size_t count = N == 8 ? 3 * 5 * 7 : 1 << 16;
+	const int repetitions = (1 << 24) / count;
+	const double elements = 1.0 * repetitions * count;
+	shape_t shape = precompute_shape(3, extents);
+
+	static uint indices[1 << 16], z[1 << 16], y[1 << 16], x[1 << 16];
+	uint *coordinates[3] = { z, y, x };
+	for (size_t i = 0; i < count; i++)
+		indices[i] = i;
+
+	uint64_t reference_sum = 0, reference_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		for (size_t i = 0; i < count; i++) {
+			uint index = indices[i];
+			x[i] = index % extents[2];
+			index /= extents[2];
+			y[i] = index % extents[1];
+			z[i] = index / extents[1];
+		}
+		reference_sum += z[r % count] + y[r % count] + x[r % count];
+	}
+	uint64_t reference_end = get_nanoseconds();
+	printf("Standard division took %.3f nanoseconds per index\n", (reference_end - reference_start) / elements);
+
+	uint64_t scalar_sum = 0, scalar_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		for (size_t i = 0; i < count; i++) {
+			uint c[3];
+			unravel_index(indices[i], &shape, c);
+			z[i] = c[0];
+			y[i] = c[1];
+			x[i] = c[2];
+		}
+		scalar_sum += z[r % count] + y[r % count] + x[r % count];
+	}
+	uint64_t scalar_end = get_nanoseconds();
+	printf("unravel_index took %.3f nanoseconds per index\n", (scalar_end - scalar_start) / elements);
+
+	uint64_t batch_sum = 0, batch_start = get_nanoseconds();
+	for (int r = 0; r < repetitions; r++) {
+		unravel_index_batch(indices, count, &shape, coordinates);
+		batch_sum += z[r % count] + y[r % count] + x[r % count];
+	}
+	uint64_t batch_end = get_nanoseconds();
+	printf("unravel_index_batch took %.3f nanoseconds per index\n", (batch_end - batch_start) / elements);
+
+	assert(scalar_sum == reference_sum);
+	assert(batch_sum == reference_sum);
+}
@@ -0,0 +1,91 @@
+#ifndef UNRAVEL_H
+#define UNRAVEL_H
+
+#include <stddef.h>
+#include <string.h>
+#include "../../common/bits.h"
+#include "../runtime/unsigned_division.h"
+
+#define MAX_RANK 8
+
+// The extents of a row-major (C order) array, where the last coordinate varies
+// fastest, together with the division data for each extent.
+typedef struct {
+	uint rank;
+	uint extents[MAX_RANK];
+	udivdata_t divdata[MAX_RANK];
+} shape_t;
+
+shape_t precompute_shape(uint rank, const uint *extents);
+void unravel_index(uint index, const shape_t *shape, uint *__restrict__ coordinates);
+uint ravel_index(const uint *coordinates, const shape_t *shape);
+void unravel_dimension(uint *__restrict__ remaining, uint *__restrict__ coordinate, size_t count, uint extent, udivdata_t dd);
+void unravel_index_batch(const uint *indices, size_t count, const shape_t *shape, uint *const *coordinates);
+
+// Precompute the division data for all extents of a shape.
+shape_t precompute_shape(uint rank, const uint *extents) {
+	assert(rank >= 1 && rank <= MAX_RANK);
+	shape_t shape;
+	shape.rank = rank;
+	for (uint k = 0; k < rank; k++) {
+		assert(extents[k] > 0);
+		shape.extents[k] = extents[k];
+		shape.divdata[k] = precompute_unsigned(extents[k]);
+	}
+	return shape;
+}
+
+// Compute the coordinates of the element with the given flat index. Starting
+// from the last dimension, the quotient of the division by its extent is the
+// flat index in the remaining dimensions, so every dimension but the first
+// costs one fast division and the remainder is computed from the quotient.
+// The loop has a fixed trip count with an early exit, so that it can be
+// unrolled completely and inlined into the caller; a loop over the rank alone
+// is slower than hardware division.
+inline void unravel_index(uint index, const shape_t *shape, uint *__restrict__ coordinates) {
+	uint rank = shape->rank;
+	// The pragma does not expand macros, so its count must be kept in sync
+	static_assert(MAX_RANK <= 8, "unroll count is less than MAX_RANK");
+	#pragma GCC unroll 8
+	for (uint j = 1; j < MAX_RANK; j++) {
+		if (j >= rank) break;
+		uint k = rank - j;
+		uint q = fast_unsigned_divide(index, shape->divdata[k]);
+		coordinates[k] = index - q * shape->extents[k];
+		index = q;
+	}
+	coordinates[0] = index;
+}
+
+// Compute the flat index of the element with the given coordinates.
+uint ravel_index(const uint *coordinates, const shape_t *shape) {
+	uint index = coordinates[0];
+	for (uint k = 1; k < shape->rank; k++)
+		index = index * shape->extents[k] + coordinates[k];
+	return index;
+}
+
+// Divide remaining[i] by extent, store the remainder in coordinate[i] and the
+// quotient in remaining[i]. The arrays must not overlap, and the loop is
+// vectorized as described for the batch forms in the README.
+__attribute__((optimize("tree-vectorize")))
+void unravel_dimension(uint *__restrict__ remaining, uint *__restrict__ coordinate, size_t count, uint extent, udivdata_t dd) {
+	for (size_t i = 0; i < count; i++) {
+		uint q = fast_unsigned_divide(remaining[i], dd);
+		coordinate[i] = remaining[i] - q * extent;
+		remaining[i] = q;
+	}
+}
+
+// Unravel count indices at once. coordinates[k] is an array of count elements
+// which receives coordinate k of every index, and these arrays must not overlap
+// each other or indices. coordinates[0] is used to hold the flat index in the
+// remaining dimensions while processing the others, so that every dimension is
+// a single vectorized loop.
+void unravel_index_batch(const uint *indices, size_t count, const shape_t *shape, uint *const *coordinates) {
+	memcpy(coordinates[0], indices, count * sizeof(uint));
+	for (uint k = shape->rank - 1; k > 0; k--)
+		unravel_dimension(coordinates[0], coordinates[k], count, shape->extents[k], shape->divdata[k]);
+}
+
+#endif